@@ -1,10 +1,12 @@
 #include "db.hpp"
 #include "git_utils.hpp"
 #include "ipc.hpp"
+#include "scrubber.hpp"
 #include <string_view>
 #include <iostream>
 #include <vector>
 #include <sstream>
+#include <fstream>
 #include <filesystem>
 #include <unistd.h>
 #include <sys/socket.h>
@@ -100,6 +102,20 @@ std::string get_db_path() {
     return (dir / "history.db").string();
 }
 
+std::string get_scrub_rules_path() {
+    const char* xdg_config_home = std::getenv("XDG_CONFIG_HOME");
+    fs::path dir;
+
+    if (xdg_config_home && *xdg_config_home != '\0') {
+        dir = fs::path(xdg_config_home) / "bsh";
+    } else {
+        const char* home = std::getenv("HOME");
+        dir = fs::path(home) / ".config" / "bsh";
+    }
+
+    return (dir / "scrub_rules").string();
+}
+
 struct RecordTask {
     std::string cmd;
     std::string session;
@@ -116,6 +132,7 @@ std::condition_variable queue_cv;
 
 void writer_thread_loop(const std::string& db_path) {
     HistoryDB history_writer(db_path);
+    SecretScrubber scrubber(get_scrub_rules_path());
     
     history_writer.initSchema(); 
 
@@ -127,11 +144,92 @@ void writer_thread_loop(const std::string& db_path) {
             task = record_queue.front();
             record_queue.pop();
         }
+        if (scrubber.apply(task.cmd) == ScrubAction::DROP) continue;
         history_writer.logCommand(task.cmd, task.session, task.cwd, task.branch, task.exit_code, task.duration, task.timestamp);
     }
 }
 
+int scrub_existing_history() {
+    HistoryDB history(get_db_path());
+    history.initSchema();
+
+    SecretScrubber scrubber(get_scrub_rules_path());
+    auto stats = history.scrubHistory(scrubber);
+    if (!stats) return EXIT_FAILURE;
+
+    std::cout << "Scrubbed history with " << scrubber.ruleCount() << " rules: "
+              << stats->redacted << " redacted, " << stats->dropped << " dropped" << std::endl;
+    return EXIT_SUCCESS;
+}
+
+// Appends to path, resuming after the last cursor this database wrote there.
+int export_history(const std::string& path) {
+    HistoryDB history(get_db_path());
+    history.initSchema();
+
+    if (path == "-") {
+        return history.exportHistory(std::cout, 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    int64_t since = 0;
+    {
+        std::ifstream existing(path);
+        std::string line;
+        std::string cursor_prefix = "C\t" + history.sourceId() + "\t";
+        while (std::getline(existing, line)) {
+            if (!line.starts_with(cursor_prefix)) continue;
+            try {
+                since = std::max<int64_t>(since, std::stoll(line.substr(cursor_prefix.size())));
+            } catch (...) {}
+        }
+    }
+
+    std::ofstream out(path, std::ios::app);
+    if (!out) {
+        std::cerr << "Export Error: cannot open " << path << std::endl;
+        return EXIT_FAILURE;
+    }
+    auto last = history.exportHistory(out, since);
+    if (!last) return EXIT_FAILURE;
+
+    std::cout << "Exported executions " << since << " -> " << *last << " to " << path << std::endl;
+    return EXIT_SUCCESS;
+}
+
+int import_history(const std::string& path) {
+    HistoryDB history(get_db_path());
+    history.initSchema();
+    SecretScrubber scrubber(get_scrub_rules_path());
+
+    std::optional<ImportStats> stats;
+    if (path == "-") {
+        stats = history.importHistory(std::cin, scrubber);
+    } else {
+        std::ifstream in(path);
+        if (!in) {
+            std::cerr << "Import Error: cannot open " << path << std::endl;
+            return EXIT_FAILURE;
+        }
+        stats = history.importHistory(in, scrubber);
+    }
+
+    if (!stats) return EXIT_FAILURE;
+
+    std::cout << "Imported " << stats->imported << " executions, skipped " << stats->skipped << std::endl;
+    return EXIT_SUCCESS;
+}
+
 int main(int argc, char* argv[]) {
+    if (argc >= 2 && std::string_view(argv[1]) == "--scrub") {
+        return scrub_existing_history();
+    }
+    if (argc >= 3 && std::string_view(argv[1]) == "--export") {
+        return export_history(argv[2]);
+    }
+    if (argc >= 3 && std::string_view(argv[1]) == "--import") {
+        return import_history(argv[2]);
+    }
+
     daemonize();
 
     HistoryDB history(get_db_path());
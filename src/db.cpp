@@ -1,6 +1,11 @@
 #include "db.hpp"
+#include "scrubber.hpp"
 #include <iostream>
+#include <istream>
+#include <ostream>
 #include <algorithm> 
+#include <filesystem>
+#include <sys/stat.h>
 
 std::string trim_cmd(const std::string& str) {
     auto start = str.find_first_not_of(" \t\n\r");
@@ -14,6 +19,51 @@ std::string sanitize_fts_query(std::string query) {
     return "\"" + query + "\" *";
 }
 
+std::string escape_field(const std::string& field) {
+    std::string out;
+    out.reserve(field.size());
+    for (char c : field) {
+        switch (c) {
+            case '\\': out += "\\\\"; break;
+            case '\t': out += "\\t"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            default: out += c;
+        }
+    }
+    return out;
+}
+
+std::string unescape_field(std::string_view field) {
+    std::string out;
+    out.reserve(field.size());
+    for (size_t i = 0; i < field.size(); ++i) {
+        if (field[i] != '\\' || i + 1 == field.size()) {
+            out += field[i];
+            continue;
+        }
+        switch (field[++i]) {
+            case 't': out += '\t'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            default: out += field[i];
+        }
+    }
+    return out;
+}
+
+std::vector<std::string> split_fields(const std::string& line) {
+    std::vector<std::string> fields;
+    size_t start = 0;
+    while (true) {
+        size_t pos = line.find('\t', start);
+        fields.push_back(unescape_field(std::string_view(line).substr(start, pos - start)));
+        if (pos == std::string::npos) break;
+        start = pos + 1;
+    }
+    return fields;
+}
+
 HistoryDB::HistoryDB(const std::string& db_path) : db_path_(db_path) {
     db_ = std::make_unique<SQLite::Database>(db_path_, SQLite::OPEN_READWRITE | SQLite::OPEN_CREATE);
     db_->exec("PRAGMA journal_mode=WAL;");
@@ -25,7 +75,7 @@ void HistoryDB::initSchema() {
     try {
         int current_version = db_->execAndGet("PRAGMA user_version").getInt();
 
-        const int TARGET_VERSION = 4;
+        const int TARGET_VERSION = 5;
 
         bool needs_vacuum = false;
 
@@ -115,6 +165,49 @@ void HistoryDB::initSchema() {
                 current_version = 4;
                 db_->exec("PRAGMA user_version = 4");
             }
+            else if (current_version == 4) {
+                db_->exec("CREATE TABLE IF NOT EXISTS meta ("
+                          "key TEXT PRIMARY KEY, "
+                          "value TEXT"
+                          ");");
+                db_->exec("INSERT OR IGNORE INTO meta (key, value) VALUES ('source_id', lower(hex(randomblob(8))));");
+
+                // Export cursors and origin_exec_id are keyed by execution id, so
+                // ids must never be reused: rebuild the table with AUTOINCREMENT.
+                // Imported executions remember the host database and id they
+                // came from, so replaying an export is a no-op.
+                db_->exec("CREATE TABLE executions_new ("
+                          "id INTEGER PRIMARY KEY AUTOINCREMENT, "
+                          "command_id INTEGER, "
+                          "session_id TEXT, "
+                          "cwd TEXT, "
+                          "git_branch TEXT, "
+                          "exit_code INTEGER, "
+                          "duration_ms INTEGER, "
+                          "timestamp INTEGER, "
+                          "origin TEXT, "
+                          "origin_exec_id INTEGER, "
+                          "FOREIGN KEY (command_id) REFERENCES commands (id)"
+                          ");");
+
+                db_->exec("INSERT INTO executions_new ("
+                          "id, command_id, session_id, cwd, git_branch, exit_code, duration_ms, timestamp) "
+                          "SELECT id, command_id, session_id, cwd, git_branch, exit_code, duration_ms, timestamp "
+                          "FROM executions;");
+
+                db_->exec("DROP TABLE executions;");
+                db_->exec("ALTER TABLE executions_new RENAME TO executions;");
+
+                db_->exec("CREATE INDEX IF NOT EXISTS idx_exec_cwd ON executions(cwd);");
+                db_->exec("CREATE INDEX IF NOT EXISTS idx_exec_branch ON executions(git_branch);");
+                db_->exec("CREATE INDEX IF NOT EXISTS idx_exec_ts ON executions(timestamp);");
+                db_->exec("CREATE UNIQUE INDEX IF NOT EXISTS idx_exec_origin ON executions(origin, origin_exec_id) WHERE origin IS NOT NULL;");
+
+                needs_vacuum = true;
+
+                current_version = 5;
+                db_->exec("PRAGMA user_version = 5");
+            }
 
             else {
                 std::cerr << "NO Migration logic for v" << current_version << "->v" << (current_version+1) << std::endl;
@@ -127,6 +220,8 @@ void HistoryDB::initSchema() {
             db_->exec("VACUUM;"); 
         }
 
+        claimSourceId();
+
         stmt_insert_cmd_ = std::make_unique<SQLite::Statement>(*db_, 
             "INSERT OR IGNORE INTO commands (cmd_text) VALUES (?)");
             
@@ -134,7 +229,8 @@ void HistoryDB::initSchema() {
             "SELECT id FROM commands WHERE cmd_text = ?");
             
         stmt_insert_exec_ = std::make_unique<SQLite::Statement>(*db_, 
-            "INSERT INTO executions (command_id, session_id, cwd, git_branch, exit_code, duration_ms, timestamp) VALUES (?, ?, ?, ?, ?, ?, ?)");
+            "INSERT OR IGNORE INTO executions (command_id, session_id, cwd, git_branch, exit_code, duration_ms, timestamp, origin, origin_exec_id) "
+            "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)");
 
         stmt_upsert_ctx_ = std::make_unique<SQLite::Statement>(*db_, 
             "INSERT INTO command_context (command_id, cwd, git_branch, success_count, last_timestamp) "
@@ -144,7 +240,7 @@ void HistoryDB::initSchema() {
             "last_timestamp = MAX(last_timestamp, excluded.last_timestamp)");
 
         stmt_update_cmd_success_ = std::make_unique<SQLite::Statement>(*db_, 
-            "UPDATE commands SET last_timestamp = ?, success_count = success_count + ? WHERE id = ?");
+            "UPDATE commands SET last_timestamp = MAX(COALESCE(last_timestamp, 0), ?), success_count = success_count + ? WHERE id = ?");
 
         stmt_search_global_ = std::make_unique<SQLite::Statement>(*db_,
             "SELECT c.id, c.cmd_text FROM commands_fts fts "
@@ -189,61 +285,116 @@ void HistoryDB::initSchema() {
     }
 }
 
-void HistoryDB::logCommand(const std::string& raw_cmd, const std::string& session, 
+bool HistoryDB::logCommand(const std::string& raw_cmd, const std::string& session, 
                            const std::string& cwd, const std::string& branch, 
                            int exit_code, int duration, long long timestamp) {
     
     std::string cmd = trim_cmd(raw_cmd);
-    if (cmd.empty()) return; 
+    if (cmd.empty()) return false; 
 
     if (cmd.starts_with("bsh ") || cmd == "bsh" || 
         cmd.starts_with("./bsh ") || cmd == "./bsh") {
-        return;
+        return false;
     }
 
     try {
-        stmt_insert_cmd_->reset();
-        stmt_insert_cmd_->bind(1, cmd);
-        stmt_insert_cmd_->exec();
-
-        stmt_get_id_->reset();
-        stmt_get_id_->bind(1, cmd);
-        if (stmt_get_id_->executeStep()) {
-            int cmd_id = stmt_get_id_->getColumn(0);
-            std::string safe_branch = branch.empty() ? "" : branch;
-            int is_success = (exit_code == 0) ? 1 : 0;
-
-            stmt_insert_exec_->reset();
-            stmt_insert_exec_->bind(1, cmd_id);
-            stmt_insert_exec_->bind(2, session);
-            stmt_insert_exec_->bind(3, cwd);
-            stmt_insert_exec_->bind(4, safe_branch);
-            stmt_insert_exec_->bind(5, exit_code);
-            stmt_insert_exec_->bind(6, duration);
-            stmt_insert_exec_->bind(7, (int64_t)timestamp);
-            stmt_insert_exec_->exec();
-
-            // 2. Upsert fast-path context table
-            stmt_upsert_ctx_->reset();
-            stmt_upsert_ctx_->bind(1, cmd_id);
-            stmt_upsert_ctx_->bind(2, cwd);
-            stmt_upsert_ctx_->bind(3, safe_branch);
-            stmt_upsert_ctx_->bind(4, is_success);
-            stmt_upsert_ctx_->bind(5, (int64_t)timestamp);
-            stmt_upsert_ctx_->exec();
-
-            // 3. Update fast-path global table
-            stmt_update_cmd_success_->reset();
-            stmt_update_cmd_success_->bind(1, (int64_t)timestamp);
-            stmt_update_cmd_success_->bind(2, is_success);
-            stmt_update_cmd_success_->bind(3, cmd_id);
-            stmt_update_cmd_success_->exec();
-        }
+        return storeExecution(cmd, session, cwd, branch, exit_code, duration, timestamp, "", 0);
     } catch (std::exception& e) {
         std::cerr << "Log Error: " << e.what() << std::endl;
     }
+    return false;
 }
 
+bool HistoryDB::storeExecution(const std::string& cmd, const std::string& session,
+                               const std::string& cwd, const std::string& branch,
+                               int exit_code, int duration, long long timestamp,
+                               const std::string& origin, int64_t origin_exec_id) {
+    stmt_insert_cmd_->reset();
+    stmt_insert_cmd_->bind(1, cmd);
+    stmt_insert_cmd_->exec();
+
+    stmt_get_id_->reset();
+    stmt_get_id_->bind(1, cmd);
+    if (stmt_get_id_->executeStep()) {
+        int cmd_id = stmt_get_id_->getColumn(0);
+        std::string safe_branch = branch.empty() ? "" : branch;
+        int is_success = (exit_code == 0) ? 1 : 0;
+
+        stmt_insert_exec_->reset();
+        stmt_insert_exec_->bind(1, cmd_id);
+        stmt_insert_exec_->bind(2, session);
+        stmt_insert_exec_->bind(3, cwd);
+        stmt_insert_exec_->bind(4, safe_branch);
+        stmt_insert_exec_->bind(5, exit_code);
+        stmt_insert_exec_->bind(6, duration);
+        stmt_insert_exec_->bind(7, (int64_t)timestamp);
+        if (origin.empty()) {
+            stmt_insert_exec_->bind(8);
+            stmt_insert_exec_->bind(9);
+        } else {
+            stmt_insert_exec_->bind(8, origin);
+            stmt_insert_exec_->bind(9, origin_exec_id);
+        }
+        if (stmt_insert_exec_->exec() == 0) return false;
+
+        // 2. Upsert fast-path context table
+        stmt_upsert_ctx_->reset();
+        stmt_upsert_ctx_->bind(1, cmd_id);
+        stmt_upsert_ctx_->bind(2, cwd);
+        stmt_upsert_ctx_->bind(3, safe_branch);
+        stmt_upsert_ctx_->bind(4, is_success);
+        stmt_upsert_ctx_->bind(5, (int64_t)timestamp);
+        stmt_upsert_ctx_->exec();
+
+        // 3. Update fast-path global table
+        stmt_update_cmd_success_->reset();
+        stmt_update_cmd_success_->bind(1, (int64_t)timestamp);
+        stmt_update_cmd_success_->bind(2, is_success);
+        stmt_update_cmd_success_->bind(3, cmd_id);
+        stmt_update_cmd_success_->exec();
+        return true;
+    }
+    return false;
+}
+
+
+// The source id is bound to the database file itself (canonical path and
+// inode), which only changes when history.db is actually copied. A copy
+// would otherwise share its id with the original, so it takes a fresh one
+// and keeps its existing rows attributed to the old id. Hostname and the
+// raw path are deliberately not used: they change on VM rebuilds, network
+// moves and symlinked homes without the file being copied.
+void HistoryDB::claimSourceId() {
+    source_id_ = db_->execAndGet("SELECT value FROM meta WHERE key = 'source_id'").getString();
+
+    std::error_code ec;
+    std::filesystem::path canonical = std::filesystem::canonical(db_path_, ec);
+    struct stat st;
+    if (ec || stat(canonical.c_str(), &st) != 0) return;
+    std::string owner = canonical.string() + ":" + std::to_string(st.st_ino);
+
+    std::string recorded = db_->execAndGet(
+        "SELECT COALESCE((SELECT value FROM meta WHERE key = 'source_file'), '')").getString();
+
+    if (recorded == owner) return;
+
+    SQLite::Transaction transaction(*db_);
+    if (!recorded.empty()) {
+        SQLite::Statement adopt(*db_,
+            "UPDATE executions SET origin = ?, origin_exec_id = id WHERE origin IS NULL");
+        adopt.bind(1, source_id_);
+        adopt.exec();
+
+        db_->exec("UPDATE meta SET value = lower(hex(randomblob(8))) WHERE key = 'source_id';");
+        source_id_ = db_->execAndGet("SELECT value FROM meta WHERE key = 'source_id'").getString();
+        std::cerr << "History database moved from " << recorded << ", new source id " << source_id_ << std::endl;
+    }
+
+    SQLite::Statement claim(*db_, "INSERT OR REPLACE INTO meta (key, value) VALUES ('source_file', ?)");
+    claim.bind(1, owner);
+    claim.exec();
+    transaction.commit();
+}
 
 std::vector<SearchResult> HistoryDB::search(const std::string& query, 
                                             SearchScope scope,
@@ -285,4 +436,219 @@ std::vector<SearchResult> HistoryDB::search(const std::string& query,
         std::cerr << "DB Search Error: " << e.what() << std::endl;
     }
     return results;
-}
\ No newline at end of file
+}
+
+std::optional<ScrubStats> HistoryDB::scrubHistory(const SecretScrubber& scrubber) {
+    ScrubStats stats;
+    try {
+        struct Change {
+            int64_t id;
+            ScrubAction action;
+            std::string cmd;
+        };
+        std::vector<Change> changes;
+
+        SQLite::Statement select(*db_, "SELECT id, cmd_text FROM commands");
+        while (select.executeStep()) {
+            std::string cmd = select.getColumn(1).getString();
+            ScrubAction action = scrubber.apply(cmd);
+            if (action != ScrubAction::KEEP) {
+                changes.push_back({select.getColumn(0).getInt64(), action, std::move(cmd)});
+            }
+        }
+        if (changes.empty()) return stats;
+
+        SQLite::Transaction transaction(*db_);
+
+        SQLite::Statement delete_execs(*db_, "DELETE FROM executions WHERE command_id = ?");
+        SQLite::Statement delete_ctx(*db_, "DELETE FROM command_context WHERE command_id = ?");
+        SQLite::Statement delete_cmd(*db_, "DELETE FROM commands WHERE id = ?");
+        SQLite::Statement rename_cmd(*db_, "UPDATE commands SET cmd_text = ? WHERE id = ?");
+
+        // Redacting can collapse a command onto an existing one; fold its
+        // history into the survivor (?1) before dropping the original (?2).
+        SQLite::Statement merge_execs(*db_, "UPDATE executions SET command_id = ?1 WHERE command_id = ?2");
+        SQLite::Statement merge_ctx(*db_,
+            "INSERT INTO command_context (command_id, cwd, git_branch, success_count, last_timestamp) "
+            "SELECT ?1, cwd, git_branch, success_count, last_timestamp FROM command_context WHERE command_id = ?2 "
+            "ON CONFLICT(command_id, cwd, git_branch) DO UPDATE SET "
+            "success_count = success_count + excluded.success_count, "
+            "last_timestamp = MAX(last_timestamp, excluded.last_timestamp)");
+        SQLite::Statement merge_cmd(*db_,
+            "UPDATE commands SET "
+            "success_count = COALESCE(success_count, 0) + COALESCE((SELECT success_count FROM commands WHERE id = ?2), 0), "
+            "last_timestamp = MAX(COALESCE(last_timestamp, 0), COALESCE((SELECT last_timestamp FROM commands WHERE id = ?2), 0)) "
+            "WHERE id = ?1");
+
+        for (const auto& change : changes) {
+            int64_t target_id = 0;
+            if (change.action == ScrubAction::REDACT) {
+                stmt_get_id_->reset();
+                stmt_get_id_->bind(1, change.cmd);
+                if (stmt_get_id_->executeStep()) target_id = stmt_get_id_->getColumn(0).getInt64();
+                stmt_get_id_->reset();
+            }
+            if (target_id == change.id) continue;
+
+            if (change.action == ScrubAction::REDACT && target_id == 0) {
+                rename_cmd.reset();
+                rename_cmd.bind(1, change.cmd);
+                rename_cmd.bind(2, change.id);
+                rename_cmd.exec();
+                stats.redacted++;
+                continue;
+            }
+
+            if (target_id != 0) {
+                for (auto* stmt : {&merge_execs, &merge_ctx, &merge_cmd}) {
+                    stmt->reset();
+                    stmt->bind(1, target_id);
+                    stmt->bind(2, change.id);
+                    stmt->exec();
+                }
+                stats.redacted++;
+            } else {
+                delete_execs.reset();
+                delete_execs.bind(1, change.id);
+                delete_execs.exec();
+                stats.dropped++;
+            }
+
+            delete_ctx.reset();
+            delete_ctx.bind(1, change.id);
+            delete_ctx.exec();
+
+            delete_cmd.reset();
+            delete_cmd.bind(1, change.id);
+            delete_cmd.exec();
+        }
+
+        db_->exec("INSERT INTO commands_fts(commands_fts) VALUES('rebuild');");
+        transaction.commit();
+
+        // Rewrite the file and truncate the WAL so freed pages holding the
+        // original text do not linger on disk.
+        db_->exec("VACUUM;");
+        db_->exec("PRAGMA wal_checkpoint(TRUNCATE);");
+    } catch (std::exception& e) {
+        std::cerr << "Scrub Error: " << e.what() << std::endl;
+        return std::nullopt;
+    }
+    return stats;
+}
+
+// Sync format: one record per line, tab-separated, backslash-escaped fields.
+//   BSH1  <source_id>                      section header
+//   X     <origin> <origin_exec_id> <timestamp> <exit_code> <duration_ms>
+//         <session_id> <cwd> <git_branch> <cmd_text>
+//   C     <source_id> <last_exec_id>       cursor written after each section
+// Sections are only ever appended, so one file can carry incremental exports.
+std::optional<int64_t> HistoryDB::exportHistory(std::ostream& out, int64_t since_exec_id) {
+    int64_t last_id = since_exec_id;
+    try {
+        SQLite::Statement select(*db_,
+            "SELECT e.id, COALESCE(e.origin, ?), COALESCE(e.origin_exec_id, e.id), e.timestamp, "
+            "e.exit_code, e.duration_ms, e.session_id, e.cwd, e.git_branch, c.cmd_text "
+            "FROM executions e JOIN commands c ON c.id = e.command_id "
+            "WHERE e.id > ? ORDER BY e.id");
+        select.bind(1, source_id_);
+        select.bind(2, since_exec_id);
+
+        bool header_written = false;
+        while (select.executeStep()) {
+            if (!header_written) {
+                out << "BSH1\t" << source_id_ << '\n';
+                header_written = true;
+            }
+            last_id = select.getColumn(0).getInt64();
+            out << "X\t" << escape_field(select.getColumn(1).getString())
+                << '\t' << select.getColumn(2).getInt64()
+                << '\t' << select.getColumn(3).getInt64()
+                << '\t' << select.getColumn(4).getInt()
+                << '\t' << select.getColumn(5).getInt()
+                << '\t' << escape_field(select.getColumn(6).getString())
+                << '\t' << escape_field(select.getColumn(7).getString())
+                << '\t' << escape_field(select.getColumn(8).getString())
+                << '\t' << escape_field(select.getColumn(9).getString()) << '\n';
+        }
+
+        if (header_written) {
+            out << "C\t" << source_id_ << '\t' << last_id << '\n';
+        }
+        out.flush();
+    } catch (std::exception& e) {
+        std::cerr << "Export Error: " << e.what() << std::endl;
+        return std::nullopt;
+    }
+    if (!out) {
+        std::cerr << "Export Error: write failed" << std::endl;
+        return std::nullopt;
+    }
+    return last_id;
+}
+
+std::optional<ImportStats> HistoryDB::importHistory(std::istream& in, const SecretScrubber& scrubber) {
+    ImportStats stats;
+    try {
+        // Commit in batches so a running daemon's writer can take the lock
+        // between them instead of timing out behind one long transaction.
+        const int BATCH_SIZE = 1000;
+        int batched = 0;
+        auto transaction = std::make_unique<SQLite::Transaction>(*db_);
+
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.starts_with("X\t")) continue;
+
+            if (++batched == BATCH_SIZE) {
+                transaction->commit();
+                transaction = std::make_unique<SQLite::Transaction>(*db_);
+                batched = 0;
+            }
+
+            auto fields = split_fields(line);
+            if (fields.size() != 10 || fields[1].empty() || fields[1] == source_id_) {
+                stats.skipped++;
+                continue;
+            }
+
+            int64_t origin_exec_id;
+            long long timestamp;
+            int exit_code, duration;
+            try {
+                origin_exec_id = std::stoll(fields[2]);
+                timestamp = std::stoll(fields[3]);
+                exit_code = std::stoi(fields[4]);
+                duration = std::stoi(fields[5]);
+            } catch (...) {
+                stats.skipped++;
+                continue;
+            }
+
+            std::string& cmd = fields[9];
+            if (scrubber.apply(cmd) == ScrubAction::DROP) {
+                stats.skipped++;
+                continue;
+            }
+
+            std::string trimmed = trim_cmd(cmd);
+            if (trimmed.empty()) {
+                stats.skipped++;
+                continue;
+            }
+
+            if (storeExecution(trimmed, fields[6], fields[7], fields[8], exit_code, duration, timestamp,
+                               fields[1], origin_exec_id)) {
+                stats.imported++;
+            } else {
+                stats.skipped++;
+            }
+        }
+
+        transaction->commit();
+    } catch (std::exception& e) {
+        std::cerr << "Import Error: " << e.what() << std::endl;
+        return std::nullopt;
+    }
+    return stats;
+}
@@ -2,8 +2,13 @@
 #include <SQLiteCpp/SQLiteCpp.h>
 #include <string>
 #include <vector>
+#include <iosfwd>
+#include <cstdint>
+#include <optional>
 #include <memory> 
 
+class SecretScrubber;
+
 enum class SearchScope { GLOBAL, DIRECTORY, BRANCH };
 
 struct SearchResult {
@@ -11,12 +16,22 @@ struct SearchResult {
     std::string cmd;
 };
 
+struct ScrubStats {
+    int redacted = 0;
+    int dropped = 0;
+};
+
+struct ImportStats {
+    int imported = 0;
+    int skipped = 0;
+};
+
 class HistoryDB {
 public:
     explicit HistoryDB(const std::string& db_path);
     void initSchema();
     
-    void logCommand(const std::string& cmd, const std::string& session, 
+    bool logCommand(const std::string& cmd, const std::string& session, 
                     const std::string& cwd, const std::string& branch, 
                     int exit_code, int duration, long long timestamp);
 
@@ -25,8 +40,23 @@ public:
                                      const std::string& context_val,
                                      bool only_success = false); 
 
+    std::optional<ScrubStats> scrubHistory(const SecretScrubber& scrubber);
+
+    // Streams executions with id > since_exec_id; returns the last id written.
+    std::optional<int64_t> exportHistory(std::ostream& out, int64_t since_exec_id);
+    std::optional<ImportStats> importHistory(std::istream& in, const SecretScrubber& scrubber);
+
+    const std::string& sourceId() const { return source_id_; }
+
 private:
+    void claimSourceId();
+    bool storeExecution(const std::string& cmd, const std::string& session,
+                        const std::string& cwd, const std::string& branch,
+                        int exit_code, int duration, long long timestamp,
+                        const std::string& origin, int64_t origin_exec_id);
+
     std::string db_path_;
+    std::string source_id_;
     
     std::unique_ptr<SQLite::Database> db_;
     std::unique_ptr<SQLite::Statement> stmt_insert_cmd_;
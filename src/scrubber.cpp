@@ -0,0 +1,180 @@
+#include "scrubber.hpp"
+#include <fstream>
+#include <iostream>
+#include <queue>
+
+namespace {
+
+const char* const REDACTED = "<redacted>";
+
+// Patterns are matched case-insensitively; a REDACT match masks the value
+// that immediately follows the pattern.
+const char* const DEFAULT_REDACT_RULES[] = {
+    "bearer ",
+    "authorization: basic ",
+    "api_key=",
+    "apikey=",
+    "api-key: ",
+    "access_key=",
+    "secret_key=",
+    "secret_access_key=",
+    "private_key=",
+    "token=",
+    "secret=",
+    "password=",
+    "passwd=",
+    "--password ",
+    "--token ",
+};
+
+const char* const DEFAULT_DROP_RULES[] = {
+    "-----begin ",
+};
+
+bool is_value_terminator(char c) {
+    switch (c) {
+        case ' ': case '\t': case '\n': case '\r':
+        case '"': case '\'': case '`':
+        case ';': case '&': case '|':
+        case '(': case ')': case '<': case '>':
+            return true;
+        default:
+            return false;
+    }
+}
+
+char fold(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+}
+
+SecretScrubber::SecretScrubber(const std::string& rules_path) {
+    delta_.emplace_back();
+    delta_.back().fill(-1);
+    flags_.push_back(0);
+
+    for (const char* rule : DEFAULT_REDACT_RULES) addRule(rule, FLAG_REDACT);
+    for (const char* rule : DEFAULT_DROP_RULES) addRule(rule, FLAG_DROP);
+
+    // Rules file format, one per line:  "redact <pattern>" or "drop <pattern>".
+    // Everything after the first space is the pattern, trailing spaces included.
+    if (!rules_path.empty()) {
+        std::ifstream in(rules_path);
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.empty() || line[0] == '#') continue;
+
+            std::string_view view(line);
+            if (view.starts_with("redact ")) {
+                addRule(view.substr(7), FLAG_REDACT);
+            } else if (view.starts_with("drop ")) {
+                addRule(view.substr(5), FLAG_DROP);
+            } else {
+                std::cerr << "Scrub Rule Error: ignoring '" << line << "'" << std::endl;
+            }
+        }
+    }
+
+    compile();
+}
+
+void SecretScrubber::addRule(std::string_view pattern, uint8_t flag) {
+    if (pattern.empty()) return;
+
+    int32_t state = 0;
+    for (char c : pattern) {
+        uint8_t byte = static_cast<uint8_t>(fold(c));
+        if (delta_[state][byte] == -1) {
+            delta_[state][byte] = static_cast<int32_t>(delta_.size());
+            delta_.emplace_back();
+            delta_.back().fill(-1);
+            flags_.push_back(0);
+        }
+        state = delta_[state][byte];
+    }
+    flags_[state] |= flag;
+    rule_count_++;
+}
+
+void SecretScrubber::compile() {
+    std::vector<int32_t> fail(delta_.size(), 0);
+    std::queue<int32_t> pending;
+
+    for (int c = 0; c < 256; ++c) {
+        int32_t next = delta_[0][c];
+        if (next == -1) {
+            delta_[0][c] = 0;
+        } else {
+            fail[next] = 0;
+            pending.push(next);
+        }
+    }
+
+    // BFS turns the trie into a complete DFA: missing edges borrow the
+    // failure state's edge, and each state inherits its suffix's flags.
+    while (!pending.empty()) {
+        int32_t state = pending.front();
+        pending.pop();
+        flags_[state] |= flags_[fail[state]];
+
+        for (int c = 0; c < 256; ++c) {
+            int32_t next = delta_[state][c];
+            if (next == -1) {
+                delta_[state][c] = delta_[fail[state]][c];
+            } else {
+                fail[next] = delta_[fail[state]][c];
+                pending.push(next);
+            }
+        }
+    }
+
+    for (auto& row : delta_) {
+        for (int c = 'A'; c <= 'Z'; ++c) {
+            row[c] = row[c + ('a' - 'A')];
+        }
+    }
+}
+
+ScrubAction SecretScrubber::apply(std::string& cmd) const {
+    const size_t size = cmd.size();
+    std::string out;
+    size_t copied = 0;
+    int32_t state = 0;
+
+    for (size_t i = 0; i < size; ++i) {
+        state = delta_[state][static_cast<uint8_t>(cmd[i])];
+        uint8_t flag = flags_[state];
+        if (flag == 0) continue;
+        if (flag & FLAG_DROP) return ScrubAction::DROP;
+
+        size_t start = i + 1;
+        while (start < size && (cmd[start] == ' ' || cmd[start] == '\t')) start++;
+
+        size_t end = start;
+        if (start < size && (cmd[start] == '"' || cmd[start] == '\'')) {
+            char quote = cmd[start++];
+            end = start;
+            while (end < size && cmd[end] != quote) end++;
+        } else {
+            while (end < size && !is_value_terminator(cmd[end])) end++;
+        }
+        if (end == start) continue;
+        if (std::string_view(cmd).substr(start, end - start) == REDACTED) continue;
+
+        out.append(cmd, copied, start - copied);
+        out += REDACTED;
+        copied = end;
+
+        i = end - 1;
+        state = 0;
+    }
+
+    if (copied == 0) return ScrubAction::KEEP;
+
+    out.append(cmd, copied, std::string::npos);
+    if (out == cmd) return ScrubAction::KEEP;
+    cmd = std::move(out);
+    return ScrubAction::REDACT;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <cstdint>
+
+enum class ScrubAction { KEEP, REDACT, DROP };
+
+// Multi-pattern secret matcher. All rules are compiled once into a single
+// case-insensitive Aho-Corasick DFA, so scrubbing a command is one table
+// lookup per byte regardless of how many rules are configured.
+class SecretScrubber {
+public:
+    explicit SecretScrubber(const std::string& rules_path = "");
+
+    // Rewrites cmd in place when a REDACT rule matches. Returns DROP if the
+    // command must not be stored at all.
+    ScrubAction apply(std::string& cmd) const;
+
+    size_t ruleCount() const { return rule_count_; }
+
+private:
+    static constexpr uint8_t FLAG_REDACT = 1;
+    static constexpr uint8_t FLAG_DROP = 2;
+
+    void addRule(std::string_view pattern, uint8_t flag);
+    void compile();
+
+    std::vector<std::array<int32_t, 256>> delta_;
+    std::vector<uint8_t> flags_;
+    size_t rule_count_ = 0;
+};